@@ -25,13 +25,14 @@ int main(int argc, char **argv){
   const string input_file(argv[1]);
   const string output_file(argv[2]);
 
-  Image an_image;
-  if (!ReadImage(input_file, &an_image)) {
+  MappedImage input_image;
+  if (!MapImage(input_file, &input_image)) {
     cout <<"Can't open file " << input_file << endl;
     return 0;
   }
 
-  LocateEdges(&an_image);
+  Image an_image;
+  LocateEdges(input_image.view(), &an_image);
   
   if (!WriteImage(output_file, an_image)){
     cout << "Can't write to file " << output_file << endl;
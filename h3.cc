@@ -3,9 +3,12 @@
  * Author         : Renat Khalikov
  * Created on     : October 31, 2017
  * Description    : generates an image of the Hough Transform space of a given
- *                  binary edge image
+ *                  binary edge image. An optional last argument picks how
+ *                  the edge pixels vote: "standard" (the default) or
+ *                  "kernel" (see HoughVotingMode in image.h).
  * Purpose        :
  * Usage          : ./h3 hough_simple_h2_output.pgm hough_simple_h3_output.pgm output_hough_voting_array.txt
+ *                  ./h3 hough_simple_h2_output.pgm hough_simple_h3_output.pgm output_hough_voting_array.txt kernel
  * Build with     : make all
  */
 #include "image.h"
@@ -19,24 +22,32 @@ using namespace std;
 using namespace ComputerVisionProjects;
 
 int main(int argc, char **argv){
-  if (argc!=4) {
-    printf("Usage: %s {input binary edge image} {output gray-level Hough image} {output Hough-voting-array}\n", argv[0]);
+  if (argc!=4 && argc!=5) {
+    printf("Usage: %s {input binary edge image} {output gray-level Hough image} {output Hough-voting-array} [{voting mode: standard or kernel}]\n", argv[0]);
     return 0;
   }
   const string input_file(argv[1]);
   const string output_gray_level_hough_image(argv[2]);
   const string output_hough_voting_array(argv[3]);
+  const string voting_mode(argc == 5 ? argv[4] : "standard");
+  if (voting_mode != "standard" && voting_mode != "kernel") {
+    cout << "Unknown voting mode " << voting_mode << endl;
+    return 0;
+  }
 
-  Image an_image;
-  if (!ReadImage(input_file, &an_image)) {
+  MappedImage an_image;
+  if (!MapImage(input_file, &an_image)) {
     cout <<"Can't open file " << input_file << endl;
     return 0;
   }
   // create and fill dimentions of hough image
-  int row = an_image.GetNumberOfRows();
-  int column = an_image.GetNumberOfColumns();
-  int _accu_h = sqrt((row*row) + (column*column));
-  int _accu_w = 360;
+  size_t _accu_h, _accu_w;
+  if (!HoughAccumulatorSizeForImage(an_image.view().num_rows(),
+                                    an_image.view().num_columns(),
+                                    &_accu_h, &_accu_w)) {
+    cout << "Image " << input_file << " is too large" << endl;
+    return 0;
+  }
   Image hough_image;
   hough_image.AllocateSpaceAndSetSize(_accu_h, _accu_w);
   hough_image.SetNumberGrayLevels(255);
@@ -45,7 +56,8 @@ int main(int argc, char **argv){
     cerr << "Could not open: {output database}\n";
     exit(1); // 1 indicates an error occurred
   }
-  HoughTransform(&an_image, &hough_image, output_filename);
+  HoughTransform(an_image.view(), &hough_image, output_filename, nullptr,
+                 voting_mode == "kernel" ? kKernelVoting : kStandardVoting);
 
   if (!WriteImage(output_gray_level_hough_image, hough_image)){
     cout << "Can't write to file " << output_gray_level_hough_image << endl;
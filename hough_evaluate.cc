@@ -0,0 +1,321 @@
+/******************************************************************************
+ * Title          : hough_evaluate.cc
+ * Description    : measures how well and how fast each line detection
+ *                  configuration finds lines. Renders synthetic scenes whose
+ *                  region boundaries are lines with known (rho, theta), adds
+ *                  noise, clutter and occluders, runs every configuration on
+ *                  them and reports recall, precision, the rho/theta error of
+ *                  the found lines and the time spent in each stage.
+ * Purpose        :
+ * Usage          : ./hough_evaluate 20 8 1
+ * Build with     : make all
+ */
+#include "image.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace ComputerVisionProjects;
+
+namespace {
+
+const size_t kSceneRows = 240;
+const size_t kSceneColumns = 320;
+const int kLinesPerScene = 4;
+const int kClutterPerScene = 8;
+const int kOccludersPerScene = 2;
+
+// A detected line matches a scene line if it is this close.
+const double kRhoTolerance = 4.0;                  // pixels
+const double kThetaTolerance = 2.0 * M_PI / 180;   // radians
+
+// A line x cos(theta) + y sin(theta) = rho, with x the column and y the
+// row and theta in [0, pi).
+struct SceneLine {
+  double rho;
+  double theta;
+};
+
+// Whether line has a bin in the Hough voting array, which only holds
+// rho >= 0. Lines with rho < 0 can still be found near theta 0 or pi.
+bool IsRepresentable(const SceneLine &line) {
+  return line.rho >= 0;
+}
+
+// One way of running the pipeline.
+struct DetectionConfig {
+  const char *name;
+  int edge_threshold;   // gray-level threshold of the edge image (h2)
+  HoughVotingMode mode;
+  int hough_threshold;  // threshold for the maxima of the accumulator (h4)
+};
+
+const DetectionConfig kConfigs[] = {
+  {"standard edges>100 h100", 100, kStandardVoting, 100},
+  {"standard edges>150 h100", 150, kStandardVoting, 100},
+  {"standard edges>170 h80", 170, kStandardVoting, 80},
+  {"kernel edges>150 h100", 150, kKernelVoting, 100},
+  {"kernel edges>150 h60", 150, kKernelVoting, 60},
+  {"kernel edges>170 h60", 170, kKernelVoting, 60},
+};
+
+// Totals for one configuration over all scenes.
+struct DetectionResult {
+  DetectionResult(): scene_lines{0}, detected_lines{0}, matched_lines{0},
+      unrepresentable_lines{0}, matched_unrepresentable_lines{0},
+      rho_error{0}, theta_error{0}, edges_time{0}, binary_time{0},
+      vote_time{0}, detect_time{0} { }
+
+  int scene_lines;
+  int detected_lines;
+  int matched_lines;
+  // scene lines without a bin (see IsRepresentable()), and how many of
+  // them were matched; they are also counted in the totals above
+  int unrepresentable_lines;
+  int matched_unrepresentable_lines;
+  double rho_error;     // summed over the matched lines
+  double theta_error;   // summed over the matched lines
+  double edges_time;    // seconds
+  double binary_time;
+  double vote_time;
+  double detect_time;
+};
+
+// Picks a line through two random points of the image that are at least
+// half its diagonal apart.
+SceneLine RandomSceneLine(mt19937 *random) {
+  uniform_real_distribution<double> x_distribution(0, kSceneColumns - 1);
+  uniform_real_distribution<double> y_distribution(0, kSceneRows - 1);
+  const double min_length = 0.5 * hypot(kSceneColumns, kSceneRows);
+  while (true) {
+    const double x0 = x_distribution(*random), y0 = y_distribution(*random);
+    const double x1 = x_distribution(*random), y1 = y_distribution(*random);
+    const double length = hypot(x1 - x0, y1 - y0);
+    if (length < min_length) continue;
+    // unit normal, turned into [0, pi)
+    double normal_x = (y0 - y1) / length;
+    double normal_y = (x1 - x0) / length;
+    if (normal_y < 0 || (normal_y == 0 && normal_x < 0)) {
+      normal_x = -normal_x;
+      normal_y = -normal_y;
+    }
+    SceneLine line;
+    line.theta = atan2(normal_y, normal_x);
+    line.rho = x0 * normal_x + y0 * normal_y;
+    return line;
+  }
+}
+
+// Returns the rho and theta differences between two lines, taking into
+// account that (rho, theta) and (-rho, theta - pi) are the same line.
+void LineDifference(const SceneLine &a, const SceneLine &b,
+                    double *rho_difference, double *theta_difference) {
+  *rho_difference = fabs(a.rho - b.rho);
+  *theta_difference = fabs(a.theta - b.theta);
+  const double wrapped_rho = fabs(a.rho + b.rho);
+  const double wrapped_theta = fabs(M_PI - *theta_difference);
+  if (wrapped_rho / kRhoTolerance + wrapped_theta / kThetaTolerance <
+      *rho_difference / kRhoTolerance + *theta_difference / kThetaTolerance) {
+    *rho_difference = wrapped_rho;
+    *theta_difference = wrapped_theta;
+  }
+}
+
+void FillRectangle(size_t first_row, size_t first_column, size_t num_rows,
+                   size_t num_columns, int gray_level, Image *scene) {
+  for (size_t i = first_row; i < min(first_row + num_rows, kSceneRows); ++i)
+    for (size_t j = first_column;
+         j < min(first_column + num_columns, kSceneColumns); ++j)
+      scene->SetPixel(i, j, gray_level);
+}
+
+// Renders a scene whose regions are bounded by kLinesPerScene random
+// lines: each line brightens the side its normal points to. Then adds
+// small clutter rectangles, occluders hiding parts of the lines, and
+// gaussian noise of the given standard deviation.
+void RenderScene(double noise, mt19937 *random, Image *scene,
+                 vector<SceneLine> *lines) {
+  lines->clear();
+  while (lines->size() < kLinesPerScene) {
+    const SceneLine line = RandomSceneLine(random);
+    // keep the lines apart so that each detected line matches one of them
+    bool distinct = true;
+    for (size_t k = 0; k < lines->size(); ++k) {
+      double rho_difference, theta_difference;
+      LineDifference(line, (*lines)[k], &rho_difference, &theta_difference);
+      if (rho_difference < 5 * kRhoTolerance &&
+          theta_difference < 5 * kThetaTolerance)
+        distinct = false;
+    }
+    if (distinct) lines->push_back(line);
+  }
+
+  scene->AllocateSpaceAndSetSize(kSceneRows, kSceneColumns);
+  scene->SetNumberGrayLevels(255);
+  for (size_t i = 0; i < kSceneRows; ++i) {
+    for (size_t j = 0; j < kSceneColumns; ++j) {
+      int gray_level = 40;
+      for (size_t k = 0; k < lines->size(); ++k) {
+        const SceneLine &line = (*lines)[k];
+        if (j * cos(line.theta) + i * sin(line.theta) > line.rho)
+          gray_level += 45;
+      }
+      scene->SetPixel(i, j, gray_level);
+    }
+  }
+
+  uniform_int_distribution<int> gray_distribution(0, 255);
+  uniform_int_distribution<size_t> row_distribution(0, kSceneRows - 1);
+  uniform_int_distribution<size_t> column_distribution(0, kSceneColumns - 1);
+  uniform_int_distribution<size_t> clutter_size(3, 12);
+  for (int k = 0; k < kClutterPerScene; ++k)
+    FillRectangle(row_distribution(*random), column_distribution(*random),
+                  clutter_size(*random), clutter_size(*random),
+                  gray_distribution(*random), scene);
+  uniform_int_distribution<size_t> occluder_rows(kSceneRows / 10,
+                                                 kSceneRows / 5);
+  uniform_int_distribution<size_t> occluder_columns(kSceneColumns / 10,
+                                                    kSceneColumns / 5);
+  for (int k = 0; k < kOccludersPerScene; ++k)
+    FillRectangle(row_distribution(*random), column_distribution(*random),
+                  occluder_rows(*random), occluder_columns(*random),
+                  gray_distribution(*random), scene);
+
+  if (noise <= 0) return;
+  normal_distribution<double> noise_distribution(0, noise);
+  for (size_t i = 0; i < kSceneRows; ++i) {
+    for (size_t j = 0; j < kSceneColumns; ++j) {
+      const int gray_level =
+          lround(scene->GetPixel(i, j) + noise_distribution(*random));
+      scene->SetPixel(i, j, min(max(gray_level, 0), 255));
+    }
+  }
+}
+
+double Seconds(chrono::steady_clock::time_point start,
+               chrono::steady_clock::time_point end) {
+  return chrono::duration<double>(end - start).count();
+}
+
+// Runs config on scene and adds the outcome to result.
+void EvaluateScene(const DetectionConfig &config, const Image &scene,
+                   const vector<SceneLine> &scene_lines,
+                   ScratchArena *scratch, DetectionResult *result) {
+  scratch->Reset();
+  Image an_image(scene);
+
+  const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  LocateEdges(&an_image, scratch);
+  const chrono::steady_clock::time_point edges_end = chrono::steady_clock::now();
+  ConvertToBinary(config.edge_threshold, &an_image);
+  const chrono::steady_clock::time_point binary_end = chrono::steady_clock::now();
+  HoughAccumulator accumulator;
+  AllocateHoughAccumulatorForImage(kSceneRows, kSceneColumns, scratch,
+                                   &accumulator);
+  if (config.mode == kKernelVoting)
+    VoteHoughAccumulatorWithKernels(an_image, KernelHoughParameters(),
+                                    &accumulator, scratch);
+  else
+    VoteHoughAccumulator(an_image, 0, 0, &accumulator, scratch);
+  const chrono::steady_clock::time_point vote_end = chrono::steady_clock::now();
+  vector<DetectedLine> detected_lines;
+  DetectLines(accumulator, config.hough_threshold, kSceneRows, kSceneColumns,
+              &detected_lines);
+  const chrono::steady_clock::time_point detect_end = chrono::steady_clock::now();
+
+  result->edges_time += Seconds(start, edges_end);
+  result->binary_time += Seconds(edges_end, binary_end);
+  result->vote_time += Seconds(binary_end, vote_end);
+  result->detect_time += Seconds(vote_end, detect_end);
+
+  // match every scene line to the closest unmatched detected line
+  result->scene_lines += scene_lines.size();
+  result->detected_lines += detected_lines.size();
+  vector<bool> matched(detected_lines.size(), false);
+  for (size_t k = 0; k < scene_lines.size(); ++k) {
+    int best = -1;
+    double best_distance = 0, best_rho = 0, best_theta = 0;
+    for (size_t d = 0; d < detected_lines.size(); ++d) {
+      if (matched[d]) continue;
+      SceneLine detected_line;
+      detected_line.rho = detected_lines[d].rho;
+      detected_line.theta = detected_lines[d].theta * M_PI / 180;
+      double rho_difference, theta_difference;
+      LineDifference(scene_lines[k], detected_line, &rho_difference,
+                     &theta_difference);
+      if (rho_difference > kRhoTolerance || theta_difference > kThetaTolerance)
+        continue;
+      const double distance = rho_difference / kRhoTolerance +
+                              theta_difference / kThetaTolerance;
+      if (best < 0 || distance < best_distance) {
+        best = d;
+        best_distance = distance;
+        best_rho = rho_difference;
+        best_theta = theta_difference;
+      }
+    }
+    if (!IsRepresentable(scene_lines[k])) ++result->unrepresentable_lines;
+    if (best < 0) continue;
+    matched[best] = true;
+    ++result->matched_lines;
+    if (!IsRepresentable(scene_lines[k]))
+      ++result->matched_unrepresentable_lines;
+    result->rho_error += best_rho;
+    result->theta_error += best_theta;
+  }
+}
+
+}  // namespace
+
+int main(int argc, char **argv){
+  if (argc!=4) {
+    printf("Usage: %s {number of scenes} {noise standard deviation} {random seed}\n", argv[0]);
+    return 0;
+  }
+  const int num_scenes = stoi(argv[1]);
+  const double noise = stod(argv[2]);
+  mt19937 random(stoul(argv[3]));
+
+  const size_t num_configs = sizeof kConfigs / sizeof kConfigs[0];
+  vector<DetectionResult> results(num_configs);
+  ScratchArena scratch;
+  Image scene;
+  vector<SceneLine> scene_lines;
+  for (int s = 0; s < num_scenes; ++s) {
+    RenderScene(noise, &random, &scene, &scene_lines);
+    for (size_t c = 0; c < num_configs; ++c)
+      EvaluateScene(kConfigs[c], scene, scene_lines, &scratch, &results[c]);
+  }
+
+  printf("%d scenes of %zux%zu, %d lines each, noise %.1f\n", num_scenes,
+         kSceneColumns, kSceneRows, kLinesPerScene, noise);
+  printf("%-24s %7s %7s %9s %8s %10s %9s %9s %9s %9s\n", "config", "recall",
+         "unrep", "precision", "rho err", "theta err", "edges ms",
+         "binary ms", "vote ms", "detect ms");
+  for (size_t c = 0; c < num_configs; ++c) {
+    const DetectionResult &result = results[c];
+    const int matched = max(result.matched_lines, 1);
+    printf("%-24s %7.3f %7.3f %9.3f %8.2f %10.2f %9.3f %9.3f %9.3f %9.3f\n",
+           kConfigs[c].name,
+           double(result.matched_lines) / max(result.scene_lines, 1),
+           double(result.matched_unrepresentable_lines) /
+               max(result.unrepresentable_lines, 1),
+           double(result.matched_lines) / max(result.detected_lines, 1),
+           result.rho_error / matched,
+           result.theta_error / matched * 180 / M_PI,
+           1000 * result.edges_time / max(num_scenes, 1),
+           1000 * result.binary_time / max(num_scenes, 1),
+           1000 * result.vote_time / max(num_scenes, 1),
+           1000 * result.detect_time / max(num_scenes, 1));
+  }
+  printf("%d of %d scene lines have rho < 0 and no bin in the Hough voting"
+         " array; unrep is the recall of those lines\n",
+         results[0].unrepresentable_lines, results[0].scene_lines);
+  printf("rho err in pixels, theta err in degrees, times per scene\n");
+}
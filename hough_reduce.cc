@@ -0,0 +1,72 @@
+/******************************************************************************
+ * Title          : hough_reduce.cc
+ * Description    : sums the partial accumulators written by hough_shard for
+ *                  all tiles of an image and finds the lines of the result,
+ *                  using a given threshold. The output file ends in .csv,
+ *                  .json or .bin for the detected lines (see LineFormat in
+ *                  image.h), or in .txt for the summed Hough-voting-array,
+ *                  which h4 reads.
+ * Purpose        :
+ * Usage          : ./hough_reduce 175 hough_simple_1_lines.csv hough_simple_1_shard_*.acc
+ * Build with     : make all
+ */
+#include "image.h"
+#include <cstdio>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace ComputerVisionProjects;
+
+int main(int argc, char **argv){
+  if (argc < 4) {
+    printf("Usage: %s {input Hough threshold value} {output line list or Hough-voting-array} {input partial accumulator} [{input partial accumulator} ...]\n", argv[0]);
+    return 0;
+  }
+  const int threshold_value = stoi(argv[1]);  // convert string to int
+  const string output_file(argv[2]);
+
+  ScratchArena scratch;
+  HoughAccumulator accumulator;
+  HoughShard shard;
+  vector<bool> merged;
+  for (int i = 3; i < argc; ++i) {
+    if (!MergePartialHoughAccumulator(argv[i], &scratch, &shard,
+                                      &accumulator)) {
+      cout << "Can't merge file " << argv[i] << endl;
+      return 1;
+    }
+    if (merged.empty())
+      merged.resize(shard.grid_rows * shard.grid_columns, false);
+    if (merged[shard.index]) {
+      cout << "Shard " << shard.index << " merged twice: " << argv[i] << endl;
+      return 1;
+    }
+    merged[shard.index] = true;
+  }
+  for (size_t index = 0; index < merged.size(); ++index) {
+    if (!merged[index]) {
+      cout << "Shard " << index << " of the " << shard.grid_rows << "x"
+           << shard.grid_columns << " grid is missing" << endl;
+      return 1;
+    }
+  }
+
+  LineFormat line_format;
+  const bool write_lines = LineFormatFromFilename(output_file, &line_format);
+  ofstream output(output_file, ios::binary);
+  if (write_lines) {
+    vector<DetectedLine> lines;
+    DetectLines(accumulator, threshold_value, shard.num_rows,
+                shard.num_columns, &lines);
+    WriteLines(lines, line_format, output);
+  } else {
+    WriteHoughVotingArray(accumulator, output);
+  }
+  if (!output) {
+    cout << "Can't write to file " << output_file << endl;
+    return 1;
+  }
+}
@@ -0,0 +1,101 @@
+/******************************************************************************
+ * Title          : hough_shard.cc
+ * Description    : computes the Hough Transform votes of one tile of a
+ *                  gray-level image and writes them as a partial
+ *                  accumulator. The image is split into a grid of
+ *                  {shard grid rows} x {shard grid columns} tiles, numbered
+ *                  row by row from 0; each tile is read with a one-pixel
+ *                  halo so that its edges match those of the whole image,
+ *                  and votes with its position in the whole image.
+ *                  hough_reduce sums the partial accumulators of all tiles.
+ * Purpose        :
+ * Usage          : ./hough_shard hough_simple_1.pgm 150 2 2 0 hough_simple_1_shard_0.acc
+ * Build with     : make all
+ */
+#include "image.h"
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+using namespace std;
+using namespace ComputerVisionProjects;
+
+int main(int argc, char **argv){
+  if (argc!=7) {
+    printf("Usage: %s {input gray-level image} {input gray-level threshold} {shard grid rows} {shard grid columns} {shard index} {output partial accumulator}\n", argv[0]);
+    return 0;
+  }
+  const string input_file(argv[1]);
+  const int threshold_value = stoi(argv[2]);  // convert string to int
+  const int grid_rows = stoi(argv[3]);
+  const int grid_columns = stoi(argv[4]);
+  const int shard_index = stoi(argv[5]);
+  const string output_file(argv[6]);
+  if (grid_rows <= 0 || grid_columns <= 0 || shard_index < 0 ||
+      shard_index >= grid_rows * grid_columns) {
+    cout << "Shard index " << shard_index << " is not in a " << grid_rows
+         << "x" << grid_columns << " grid" << endl;
+    return 1;
+  }
+
+  MappedImage an_image;
+  if (!MapImage(input_file, &an_image)) {
+    cout <<"Can't open file " << input_file << endl;
+    return 1;
+  }
+  const ImageView &whole_image = an_image.view();
+  const size_t row = whole_image.num_rows();
+  const size_t column = whole_image.num_columns();
+
+  // the tile, and the tile with its halo
+  const size_t grid_row = shard_index / grid_columns;
+  const size_t grid_column = shard_index % grid_columns;
+  const size_t first_row = grid_row * row / grid_rows;
+  const size_t last_row = (grid_row + 1) * row / grid_rows;
+  const size_t first_column = grid_column * column / grid_columns;
+  const size_t last_column = (grid_column + 1) * column / grid_columns;
+  const size_t halo_first_row = first_row > 0 ? first_row - 1 : 0;
+  const size_t halo_last_row = min(last_row + 1, row);
+  const size_t halo_first_column = first_column > 0 ? first_column - 1 : 0;
+  const size_t halo_last_column = min(last_column + 1, column);
+
+  ScratchArena scratch;
+  Image edge_image;
+  LocateEdges(whole_image.SubView(halo_first_row, halo_first_column,
+                                  halo_last_row - halo_first_row,
+                                  halo_last_column - halo_first_column),
+              &edge_image, &scratch);
+  ConvertToBinary(threshold_value, &edge_image);
+
+  // the halo belongs to the neighbouring tiles, which vote for it
+  for (size_t i = 0; i < edge_image.num_rows(); ++i) {
+    for (size_t j = 0; j < edge_image.num_columns(); ++j) {
+      const size_t image_row = halo_first_row + i;
+      const size_t image_column = halo_first_column + j;
+      if (image_row < first_row || image_row >= last_row ||
+          image_column < first_column || image_column >= last_column)
+        edge_image.SetPixel(i, j, 0);
+    }
+  }
+
+  HoughAccumulator accumulator;
+  if (!AllocateHoughAccumulatorForImage(row, column, &scratch,
+                                        &accumulator)) {
+    cout << "Image " << input_file << " is too large" << endl;
+    return 1;
+  }
+  VoteHoughAccumulator(edge_image, halo_first_row, halo_first_column,
+                       &accumulator, &scratch);
+
+  HoughShard shard;
+  shard.num_rows = row;
+  shard.num_columns = column;
+  shard.grid_rows = grid_rows;
+  shard.grid_columns = grid_columns;
+  shard.index = shard_index;
+  if (!WritePartialHoughAccumulator(output_file, shard, accumulator)) {
+    cout << "Can't write to file " << output_file << endl;
+    return 1;
+  }
+}
@@ -13,19 +13,45 @@
 #include <string>
 #include <cmath>
 #include <vector>
+#include <algorithm>
+#include <utility>
+#include <cctype>
+#include <cstdint>
+#include <limits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 using namespace std;
 
 namespace ComputerVisionProjects {
 
-Image::Image(const Image &an_image){
+Image::Image(const Image &an_image): Image() {
   AllocateSpaceAndSetSize(an_image.num_rows(), an_image.num_columns());
   SetNumberGrayLevels(an_image.num_gray_levels());
+  copy(an_image.data_, an_image.data_ + num_rows() * num_columns(), data_);
+}
 
-  for (size_t i = 0; i < num_rows(); ++i)
-    for (size_t j = 0; j < num_columns(); ++j){
-      SetPixel(i,j, an_image.GetPixel(i,j));
-    }
+Image::Image(Image &&an_image) noexcept: Image() {
+  *this = std::move(an_image);
+}
+
+Image&
+Image::operator=(Image &&an_image) noexcept {
+  if (this == &an_image) return *this;
+  DeallocateSpace();
+  num_rows_ = an_image.num_rows_;
+  num_columns_ = an_image.num_columns_;
+  num_gray_levels_ = an_image.num_gray_levels_;
+  pixels_ = an_image.pixels_;
+  data_ = an_image.data_;
+  an_image.num_rows_ = 0;
+  an_image.num_columns_ = 0;
+  an_image.num_gray_levels_ = 0;
+  an_image.pixels_ = nullptr;
+  an_image.data_ = nullptr;
+  return *this;
 }
 
 Image::~Image(){
@@ -34,10 +60,13 @@ Image::~Image(){
 
 void
 Image::AllocateSpaceAndSetSize(size_t num_rows, size_t num_columns) {
+  if (pixels_ != nullptr && num_rows == num_rows_ &&
+      num_columns == num_columns_) return;
   if (pixels_ != nullptr) DeallocateSpace();
+  data_ = new int[num_rows * num_columns];
   pixels_ = new int*[num_rows];
   for (size_t i = 0; i < num_rows; ++i)
-    pixels_[i] = new int[num_columns];
+    pixels_[i] = data_ + i * num_columns;
 
   num_rows_ = num_rows;
   num_columns_ = num_columns;
@@ -45,14 +74,55 @@ Image::AllocateSpaceAndSetSize(size_t num_rows, size_t num_columns) {
 
 void
 Image::DeallocateSpace() {
-  for (size_t i = 0; i < num_rows_; i++)
-    delete pixels_[i];
-  delete pixels_;
+  delete [] pixels_;
+  delete [] data_;
   pixels_ = nullptr;
+  data_ = nullptr;
   num_rows_ = 0;
   num_columns_ = 0;
 }
 
+ScratchArena::~ScratchArena(){
+  DeallocateSpace();
+}
+
+void *
+ScratchArena::AllocateBytes(size_t size) {
+  // keep every allocation aligned for double
+  size = (size + sizeof(double) - 1) / sizeof(double) * sizeof(double);
+  unsigned char *space;
+  if (block_size_ - min(used_, block_size_) >= size) {
+    space = block_ + used_;
+  } else {
+    space = new unsigned char[size];
+    overflow_.push_back(space);
+  }
+  used_ += size;
+  return space;
+}
+
+void
+ScratchArena::Reset() {
+  if (!overflow_.empty()) {
+    const size_t high_water = used_;
+    DeallocateSpace();
+    block_ = new unsigned char[high_water];
+    block_size_ = high_water;
+  }
+  used_ = 0;
+}
+
+void
+ScratchArena::DeallocateSpace() {
+  for (size_t i = 0; i < overflow_.size(); ++i)
+    delete [] overflow_[i];
+  overflow_.clear();
+  delete [] block_;
+  block_ = nullptr;
+  block_size_ = 0;
+  used_ = 0;
+}
+
 bool ReadImage(const string &filename, Image *an_image) {
   if (an_image == nullptr) abort();
   FILE *input = fopen(filename.c_str(),"rb");
@@ -103,6 +173,97 @@ bool ReadImage(const string &filename, Image *an_image) {
   return true;
 }
 
+MappedImage::~MappedImage(){
+  Unmap();
+}
+
+void
+MappedImage::Unmap() {
+  if (mapping_ != nullptr) munmap(mapping_, mapping_size_);
+  mapping_ = nullptr;
+  mapping_size_ = 0;
+  view_ = ImageView();
+}
+
+// Reads one unsigned decimal pgm header value starting at *offset,
+// skipping leading whitespace and comments. Advances *offset past it.
+static bool ReadHeaderValue(const unsigned char *bytes, size_t size,
+  size_t *offset, size_t *value) {
+  size_t i = *offset;
+  while (i < size && (isspace(bytes[i]) || bytes[i] == '#')) {
+    if (bytes[i] == '#')
+      while (i < size && bytes[i] != '\n') ++i;
+    else
+      ++i;
+  }
+  if (i >= size || !isdigit(bytes[i])) return false;
+  size_t result = 0;
+  while (i < size && isdigit(bytes[i])) {
+    result = result * 10 + (bytes[i] - '0');
+    if (result > 1000000) return false;
+    ++i;
+  }
+  *offset = i;
+  *value = result;
+  return true;
+}
+
+bool MapImage(const string &filename, MappedImage *mapped_image) {
+  if (mapped_image == nullptr) abort();
+  mapped_image->Unmap();
+  const int input = open(filename.c_str(), O_RDONLY);
+  if (input < 0) {
+    cout << "MapImage: Cannot open file" << endl;
+    return false;
+  }
+  struct stat input_status;
+  if (fstat(input, &input_status) != 0 || input_status.st_size == 0) {
+    close(input);
+    cout << "MapImage: Expected .pgm file" << endl;
+    return false;
+  }
+  const size_t size = input_status.st_size;
+  void *mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, input, 0);
+  close(input);
+  if (mapping == MAP_FAILED) {
+    cout << "MapImage: Cannot map file" << endl;
+    return false;
+  }
+  const unsigned char *bytes = static_cast<const unsigned char *>(mapping);
+
+  // Check for the right "magic number", then read the width, height and
+  // # of gray levels. A single whitespace separates the header from the
+  // pixels.
+  size_t offset = 2;
+  size_t num_columns, num_rows, levels;
+  if (size < 3 || bytes[0] != 'P' || bytes[1] != '5' ||
+      !ReadHeaderValue(bytes, size, &offset, &num_columns) ||
+      !ReadHeaderValue(bytes, size, &offset, &num_rows) ||
+      !ReadHeaderValue(bytes, size, &offset, &levels) ||
+      offset >= size || !isspace(bytes[offset])) {
+    munmap(mapping, size);
+    cout << "MapImage: Expected .pgm file" << endl;
+    return false;
+  }
+  ++offset;
+  if (levels > 255) {
+    munmap(mapping, size);
+    cout << "MapImage: Expected 8-bit .pgm file" << endl;
+    return false;
+  }
+  if (size - offset < num_rows * num_columns) {
+    munmap(mapping, size);
+    cout << "MapImage: short file" << endl;
+    return false;
+  }
+
+  mapped_image->mapping_ = mapping;
+  mapped_image->mapping_size_ = size;
+  mapped_image->view_ = ImageView(bytes + offset, num_rows, num_columns,
+                                  num_columns, levels);
+  return true;
+}
+
 bool WriteImage(const string &filename, const Image &an_image) {
   FILE *output = fopen(filename.c_str(), "w");
   if (output == 0) {
@@ -306,22 +467,23 @@ void ConvertToBinary(const int threshold_value, Image *an_image) {
   an_image->SetNumberGrayLevels(1);
 }
 
-/**
- * LocateEdges( ) locates edges using sobel derivatives. Sets the color of
- * image based on the gradient approximation of sobel derivatives.
- *
- * @param {Image} an_image: input image
- */
-void LocateEdges(Image *an_image){
+// Shared by both LocateEdges( ) overloads: reads source_image and writes
+// the gradient approximation to edge_image, which has the same size.
+// The two may be the same image.
+template <typename SourceImage>
+static void ComputeEdges(const SourceImage &source_image, Image *edge_image,
+  ScratchArena *scratch){
   // matrix dimensions
-  int row = an_image->GetNumberOfRows();
-  int column = an_image->GetNumberOfColumns();
+  int row = source_image.num_rows();
+  int column = source_image.num_columns();
   // sobel operator in x direction
   int sobel_x[3][3] = {{-1, 0, 1}, {-2, 0, 2}, {-1, 0, 1}};
   // sobel operator in y direction
   int sobel_y[3][3] = {{-1, -2, -1}, {0, 0, 0}, {1, 2, 1}};
-  int image_x[row][column];
-  int image_y[row][column];
+  // planes of more than INT_MAX pixels are fine: index them as size_t
+  const size_t plane_size = size_t(row) * column;
+  int *image_x = scratch->Allocate(plane_size);
+  int *image_y = scratch->Allocate(plane_size);
   for (int i = 0; i < row; ++i) {
     for (int j = 0; j < column; ++j) {
       // https://stackoverflow.com/questions/16385570/sobel-edge-detector-using-c-without-any-special-library-or-tool
@@ -331,70 +493,370 @@ void LocateEdges(Image *an_image){
       // x and y convolutions
       for (int x = -1; x <= 1; x++){
         for (int y = -1; y <= 1; y++){
-          pixel = (i == 0 || i == row-1 || j == 0 || j == column-1) ? 0 : an_image->GetPixel(i+x, j+y);
+          pixel = (i == 0 || i == row-1 || j == 0 || j == column-1) ? 0 : source_image.GetPixel(i+x, j+y);
           x_convolution = x_convolution + (pixel * sobel_x[1+x][1+y]);
           y_convolution = y_convolution + (pixel * sobel_y[1+x][1+y]);
         }
       }
-      image_x[i][j] = x_convolution;
-      image_y[i][j] = y_convolution;
+      image_x[size_t(i) * column + j] = x_convolution;
+      image_y[size_t(i) * column + j] = y_convolution;
     }
   }
   // gradient approximation
   for (int i = 0; i < row; ++i) {
     for (int j = 0; j < column; ++j) {
-      double gradient_approximation = sqrt(image_x[i][j]*image_x[i][j] + image_y[i][j]*image_y[i][j]);
-      an_image->SetPixel(i,j,gradient_approximation);
+      const int gx = image_x[size_t(i) * column + j];
+      const int gy = image_y[size_t(i) * column + j];
+      double gradient_approximation = sqrt(gx*gx + gy*gy);
+      edge_image->SetPixel(i,j,gradient_approximation);
     }
   }
 }
 
 /**
- * HoughTransform( ) creates an accumulator array of the hough space and
- * outputs the accumulator array to an output image for visualization
- * @param an_image    [input binary image]
- * @param hough_image [output hough image used for visualization]
- * @param output_file [output accumulator array to txt file]
+ * LocateEdges( ) locates edges using sobel derivatives. Sets the color of
+ * image based on the gradient approximation of sobel derivatives.
+ *
+ * @param {Image} an_image: input image
+ * @param {ScratchArena} scratch: memory for the gradient planes; a
+ *   temporary one is used if nullptr
  */
-void HoughTransform(Image *an_image, Image *hough_image, std::ostream &output_file){
-  // matrix dimensions
-  int row = an_image->GetNumberOfRows();
-  int column = an_image->GetNumberOfColumns();
+void LocateEdges(Image *an_image, ScratchArena *scratch){
+  if (an_image == nullptr) abort();
+  ScratchArena temporary_scratch;
+  ComputeEdges(*an_image, an_image,
+               scratch != nullptr ? scratch : &temporary_scratch);
+}
 
-  // the maximum height depends on the image size
-  int accu_row = sqrt((row*row) + (column*column));
-  int accu_col = 360;
+/**
+ * LocateEdges( ) same as above, but reads input_image and writes the
+ * gradient approximation to edge_image, leaving input_image untouched.
+ *
+ * @param {ImageView} input_image: input image
+ * @param {Image} edge_image: output edge image
+ * @param {ScratchArena} scratch: memory for the gradient planes; a
+ *   temporary one is used if nullptr
+ */
+void LocateEdges(const ImageView &input_image, Image *edge_image,
+  ScratchArena *scratch){
+  if (edge_image == nullptr) abort();
+  ScratchArena temporary_scratch;
+  edge_image->AllocateSpaceAndSetSize(input_image.num_rows(),
+                                      input_image.num_columns());
+  edge_image->SetNumberGrayLevels(input_image.num_gray_levels());
+  ComputeEdges(input_image, edge_image,
+               scratch != nullptr ? scratch : &temporary_scratch);
+}
 
-  // start with an accumulator array with all 0's
-  // the width contain 360 bins
-  std::vector<std::vector<int>> accumulator(accu_row, std::vector<int>(accu_col, 0));
+// Number of edge pixels VoteHough( ) takes at a time: their coordinates
+// stay in L1 cache while they vote for every θ.
+static const size_t kVoteBlockSize = 1024;
 
-  // compute r for every θ in the image
+// Shared by HoughTransform( ) and VoteHoughAccumulator( ).
+template <typename SourceImage>
+static void VoteHough(const SourceImage &an_image, int row_offset,
+  int column_offset, HoughAccumulator *accumulator, ScratchArena *scratch){
+  // matrix dimensions
+  int row = an_image.num_rows();
+  int column = an_image.num_columns();
+  int accu_row = accumulator->num_rho;
+  int accu_col = accumulator->num_theta;
+
+  // the edge pixels, in the coordinates of the whole image
+  size_t num_edges = 0;
+  for(int y = 0; y < row; y++)
+    for(int x = 0; x < column; x++)
+      if( an_image.GetPixel(y,x) != 0 ) ++num_edges;
+  int *edge_x = scratch->Allocate(num_edges);
+  int *edge_y = scratch->Allocate(num_edges);
+  num_edges = 0;
   for(int y = 0; y < row; y++){
     for(int x = 0; x < column; x++){
-      if( an_image->GetPixel(y,x) != 0 ){
-        for(int t=0;t<360;t++){
-          // r = xcos(θ) + ysin(θ)
-          double pi = atan(1)*4;
-          double theta = (pi/360);
-          double r = (x  * cos(t * theta)) + (y * sin(t * theta));
-          if (r>=0)
-            accumulator[r][t]++;
-        }
+      if( an_image.GetPixel(y,x) != 0 ){
+        edge_x[num_edges] = column_offset + x;
+        edge_y[num_edges] = row_offset + y;
+        ++num_edges;
       }
     }
   }
-  // output header for file
-  output_file << accu_row << " " << accu_col << endl;
+
+  // cos(θ) and sin(θ) for every bin
+  double *cos_theta = scratch->AllocateDoubles(accu_col);
+  double *sin_theta = scratch->AllocateDoubles(accu_col);
+  double pi = atan(1)*4;
+  double theta = (pi/accu_col);
+  for(int t=0;t<accu_col;t++){
+    cos_theta[t] = cos(t * theta);
+    sin_theta[t] = sin(t * theta);
+  }
+
+  // compute r for every θ, a block of edge pixels at a time, so that the
+  // votes for one θ land in one strip of the accumulator
+  for(size_t begin = 0; begin < num_edges; begin += kVoteBlockSize){
+    const size_t end = min(begin + kVoteBlockSize, num_edges);
+    for(int t=0;t<accu_col;t++){
+      int *strip = accumulator->votes + t * accu_row;
+      for(size_t k = begin; k < end; ++k){
+        // r = xcos(θ) + ysin(θ)
+        double r = (edge_x[k] * cos_theta[t]) + (edge_y[k] * sin_theta[t]);
+        if (r>=0)
+          strip[static_cast<int>(r)]++;
+      }
+    }
+  }
+}
+
+// 8-neighbours of a pixel, 4-connected ones first.
+static const int kNeighborRows[8] = {0, 1, 0, -1, 1, 1, -1, -1};
+static const int kNeighborColumns[8] = {1, 0, -1, 0, 1, -1, 1, -1};
+
+// Follows unvisited non-zero pixels from (y, x) for as long as there is
+// one next to the last, marking them visited and appending them to
+// (point_x, point_y) from index *count.
+template <typename SourceImage>
+static void TraceChain(const SourceImage &an_image, int y, int x,
+  int *visited, int *point_x, int *point_y, size_t *count){
+  int row = an_image.num_rows();
+  int column = an_image.num_columns();
+  while (true) {
+    int k = 0;
+    for (; k < 8; ++k) {
+      const int i = y + kNeighborRows[k];
+      const int j = x + kNeighborColumns[k];
+      if (i >= 0 && i < row && j >= 0 && j < column &&
+          !visited[size_t(i) * column + j] && an_image.GetPixel(i, j) != 0)
+        break;
+    }
+    if (k == 8) return;
+    y += kNeighborRows[k];
+    x += kNeighborColumns[k];
+    visited[size_t(y) * column + x] = 1;
+    point_x[*count] = x;
+    point_y[*count] = y;
+    ++*count;
+  }
+}
+
+// Fits a line to the cluster of count pixels (point_x, point_y) and adds
+// a gaussian kernel of votes around it to accumulator. The kernel is
+// count votes high; its width follows from the spread of the pixels
+// around the line (Fernandes and Oliveira, "Real-time line detection
+// through an improved Hough transform voting scheme", 2008).
+static void VoteCluster(const int *point_x, const int *point_y, size_t count,
+  HoughAccumulator *accumulator){
+  double mean_x = 0, mean_y = 0;
+  for (size_t k = 0; k < count; ++k) {
+    mean_x += point_x[k];
+    mean_y += point_y[k];
+  }
+  mean_x /= count;
+  mean_y /= count;
+  double sxx = 0, syy = 0, sxy = 0;
+  for (size_t k = 0; k < count; ++k) {
+    sxx += (point_x[k] - mean_x) * (point_x[k] - mean_x);
+    syy += (point_y[k] - mean_y) * (point_y[k] - mean_y);
+    sxy += (point_x[k] - mean_x) * (point_y[k] - mean_y);
+  }
+  // the normal of the line is across the direction of most spread
+  double pi = atan(1)*4;
+  double angle = 0.5 * atan2(2 * sxy, sxx - syy) + pi / 2;
+  if (angle >= pi) angle -= pi;
+
+  // spread along the line and across it, plus the pixel quantization
+  double along = 0, across = 0;
+  for (size_t k = 0; k < count; ++k) {
+    const double ex = point_x[k] - mean_x;
+    const double ey = point_y[k] - mean_y;
+    const double along_offset = -ex * sin(angle) + ey * cos(angle);
+    const double across_offset = ex * cos(angle) + ey * sin(angle);
+    along += along_offset * along_offset;
+    across += across_offset * across_offset;
+  }
+  if (along <= 0) return;
+  const double variance = across / count + 1.0 / 12;
+  // the fitted line goes through the centroid: r is uncertain by the
+  // centroid's offset, θ by the offset over the length of the cluster.
+  // θ is at least a bin, so a line between two bins votes in both, as
+  // its pixels would in standard voting.
+  const int accu_row = accumulator->num_rho;
+  const int accu_col = accumulator->num_theta;
+  const double theta = pi / accu_col;
+  const double theta_deviation = max(sqrt(variance / along), theta);
+  const double rho_deviation = max(sqrt(variance / count), 0.5);
+
+  // deposit the kernel within 2 deviations, following the line through
+  // the centroid as θ changes. Past π the same line is at θ - π with -r,
+  // so a kernel near 0 or π also votes at the other end; as with
+  // standard voting, bins where the line has a negative r are skipped.
+  const int first_t = int(floor((angle - 2 * theta_deviation) / theta));
+  const int last_t = int(ceil((angle + 2 * theta_deviation) / theta));
+  for (int t = max(first_t, last_t - accu_col + 1); t <= last_t; ++t) {
+    const int bin = ((t % accu_col) + accu_col) % accu_col;
+    const double theta_offset = (t * theta - angle) / theta_deviation;
+    const double theta_weight = count * exp(-0.5 * theta_offset * theta_offset);
+    const double r_t = mean_x * cos(bin * theta) + mean_y * sin(bin * theta);
+    if (r_t < 0) continue;
+    const int first_r = max(0, int(floor(r_t - 2 * rho_deviation - 0.5)));
+    const int last_r = min(accu_row - 1, int(ceil(r_t + 2 * rho_deviation - 0.5)));
+    for (int r = first_r; r <= last_r; ++r) {
+      // votes for r stand for [r, r+1)
+      const double rho_offset = (r + 0.5 - r_t) / rho_deviation;
+      const int votes = lround(theta_weight * exp(-0.5 * rho_offset * rho_offset));
+      if (votes > 0)
+        accumulator->At(r, bin) += votes;
+    }
+  }
+}
+
+// Splits the chain of count pixels (point_x, point_y) into approximately
+// collinear clusters and lets each vote. stack has room for 2 * count + 2
+// ints.
+static void VoteChain(const int *point_x, const int *point_y, size_t count,
+  const KernelHoughParameters &parameters, int *stack,
+  HoughAccumulator *accumulator){
+  const size_t min_cluster_size = max<size_t>(parameters.min_cluster_size, 3);
+  // below 0 (or NaN) a collinear part would be split at its first pixel,
+  // which gives back the same part forever
+  const double max_deviation = max(0.0, parameters.max_deviation);
+  stack[0] = 0;
+  stack[1] = count;
+  size_t depth = 1;
+  while (depth > 0) {
+    --depth;
+    const size_t begin = stack[2 * depth];
+    const size_t end = stack[2 * depth + 1];
+    if (end - begin < min_cluster_size) continue;
+
+    // the pixel farthest from the segment joining the ends
+    const double dx = point_x[end - 1] - point_x[begin];
+    const double dy = point_y[end - 1] - point_y[begin];
+    const double length = sqrt(dx * dx + dy * dy);
+    size_t farthest = begin;
+    double max_distance = 0;
+    for (size_t k = begin; k < end; ++k) {
+      const double ex = point_x[k] - point_x[begin];
+      const double ey = point_y[k] - point_y[begin];
+      const double distance = length > 0 ? fabs(ex * dy - ey * dx) / length
+                                         : sqrt(ex * ex + ey * ey);
+      if (distance > max_distance) {
+        max_distance = distance;
+        farthest = k;
+      }
+    }
+    if (max_distance <= max_deviation) {
+      VoteCluster(point_x + begin, point_y + begin, end - begin, accumulator);
+      continue;
+    }
+    // both parts keep the farthest pixel
+    stack[2 * depth] = begin;
+    stack[2 * depth + 1] = farthest + 1;
+    stack[2 * depth + 2] = farthest;
+    stack[2 * depth + 3] = end;
+    depth += 2;
+  }
+}
+
+// Shared by HoughTransform( ) and VoteHoughAccumulatorWithKernels( ).
+template <typename SourceImage>
+static void VoteHoughWithKernels(const SourceImage &an_image,
+  const KernelHoughParameters &parameters, ScratchArena *scratch,
+  HoughAccumulator *accumulator){
+  // matrix dimensions
+  int row = an_image.num_rows();
+  int column = an_image.num_columns();
+
+  size_t num_edges = 0;
+  for (int y = 0; y < row; y++)
+    for (int x = 0; x < column; x++)
+      if (an_image.GetPixel(y, x) != 0) ++num_edges;
+  const size_t plane_size = size_t(row) * column;
+  int *visited = scratch->Allocate(plane_size);
+  fill(visited, visited + plane_size, 0);
+  int *point_x = scratch->Allocate(num_edges);
+  int *point_y = scratch->Allocate(num_edges);
+  int *stack = scratch->Allocate(2 * num_edges + 2);
+
+  // link every chain from its first pixel in raster order, both ways
+  for (int y = 0; y < row; y++) {
+    for (int x = 0; x < column; x++) {
+      if (visited[size_t(y) * column + x] || an_image.GetPixel(y, x) == 0)
+        continue;
+      visited[size_t(y) * column + x] = 1;
+      point_x[0] = x;
+      point_y[0] = y;
+      size_t count = 1;
+      TraceChain(an_image, y, x, visited, point_x, point_y, &count);
+      const size_t forward_end = count;
+      TraceChain(an_image, y, x, visited, point_x, point_y, &count);
+      // put the backward part, reversed, in front
+      reverse(point_x + forward_end, point_x + count);
+      reverse(point_y + forward_end, point_y + count);
+      rotate(point_x, point_x + forward_end, point_x + count);
+      rotate(point_y, point_y + forward_end, point_y + count);
+      VoteChain(point_x, point_y, count, parameters, stack, accumulator);
+    }
+  }
+}
+
+// Shared by both HoughTransform( ) overloads.
+template <typename SourceImage>
+static void ComputeHoughTransform(const SourceImage &an_image,
+  Image *hough_image, std::ostream &output_file, ScratchArena *scratch,
+  HoughVotingMode mode){
+  // start with an accumulator array with all 0's
+  HoughAccumulator accumulator;
+  if (!AllocateHoughAccumulatorForImage(an_image.num_rows(),
+                                        an_image.num_columns(), scratch,
+                                        &accumulator)) abort();
+  if (mode == kKernelVoting)
+    VoteHoughWithKernels(an_image, KernelHoughParameters(), scratch,
+                         &accumulator);
+  else
+    VoteHough(an_image, 0, 0, &accumulator, scratch);
+
   // output tbe accumulator array to output file
   // as well as draw the accumulator to output image
-  for(int y = 0; y < accu_row; y++){
-    for(int x = 0; x < accu_col; x++){
-      hough_image->SetPixel(y, x, accumulator[y][x]);
-      output_file << accumulator[y][x] << " ";
+  WriteHoughVotingArray(accumulator, output_file);
+  for(size_t y = 0; y < accumulator.num_rho; y++){
+    for(size_t x = 0; x < accumulator.num_theta; x++){
+      hough_image->SetPixel(y, x, accumulator.At(y, x));
     }
   }
-  output_file << endl;
+}
+
+/**
+ * HoughTransform( ) creates an accumulator array of the hough space and
+ * outputs the accumulator array to an output image for visualization
+ * @param an_image    [input binary image]
+ * @param hough_image [output hough image used for visualization]
+ * @param output_file [output accumulator array to txt file]
+ * @param scratch     [memory for the accumulator; temporary if nullptr]
+ * @param mode        [how the pixels vote]
+ */
+void HoughTransform(Image *an_image, Image *hough_image, std::ostream &output_file,
+  ScratchArena *scratch, HoughVotingMode mode){
+  if (an_image == nullptr || hough_image == nullptr) abort();
+  ScratchArena temporary_scratch;
+  ComputeHoughTransform(*an_image, hough_image, output_file,
+                        scratch != nullptr ? scratch : &temporary_scratch,
+                        mode);
+}
+
+/**
+ * HoughTransform( ) same as above, for a binary image that is only viewed
+ * @param an_image    [input binary image]
+ * @param hough_image [output hough image used for visualization]
+ * @param output_file [output accumulator array to txt file]
+ * @param scratch     [memory for the accumulator; temporary if nullptr]
+ * @param mode        [how the pixels vote]
+ */
+void HoughTransform(const ImageView &an_image, Image *hough_image, std::ostream &output_file,
+  ScratchArena *scratch, HoughVotingMode mode){
+  if (hough_image == nullptr) abort();
+  ScratchArena temporary_scratch;
+  ComputeHoughTransform(an_image, hough_image, output_file,
+                        scratch != nullptr ? scratch : &temporary_scratch,
+                        mode);
 }
 
 /**
@@ -403,97 +865,477 @@ void HoughTransform(Image *an_image, Image *hough_image, std::ostream &output_fi
  * @param input_hough_voting_array array containing the accumulator
  * @param threshold_value          threshold value for computing maxima
  * @param an_image                 image the lines will be drawn on
+ * @param scratch                  memory for the accumulator; temporary
+ *                                 if nullptr
  */
-void DrawDetectedLines(const string input_hough_voting_array, int threshold_value, Image *an_image){
-  // matrix dimensions
-  int row = an_image->GetNumberOfRows();
-  int column = an_image->GetNumberOfColumns();
+void DrawDetectedLines(const string input_hough_voting_array, int threshold_value, Image *an_image,
+  ScratchArena *scratch){
+  if (an_image == nullptr) abort();
+  ScratchArena temporary_scratch;
+  if (scratch == nullptr) scratch = &temporary_scratch;
 
-  ifstream accumulator_values(input_hough_voting_array);
-  if (accumulator_values.fail()) {
+  HoughAccumulator accumulator;
+  if (!ReadHoughVotingArray(input_hough_voting_array, scratch, &accumulator)) {
     cerr << "Could not open: {input_hough_voting_array}\n";
     exit(1); // 1 indicates an error occurred
   }
-  string line;
-  getline(accumulator_values, line);
+  std::vector<DetectedLine> lines;
+  DetectLines(accumulator, threshold_value, an_image->num_rows(),
+              an_image->num_columns(), &lines);
+  DrawLines(lines, 255, an_image);
+}
+
+/**
+ * AllocateHoughAccumulator( ) sets accumulator to num_rho x num_theta bins
+ * taken from scratch, all 0
+ * @param num_rho     number of rho bins
+ * @param num_theta   number of theta bins
+ * @param scratch     memory for the votes
+ * @param accumulator resulting accumulator
+ */
+void AllocateHoughAccumulator(size_t num_rho, size_t num_theta,
+  ScratchArena *scratch, HoughAccumulator *accumulator){
+  if (scratch == nullptr || accumulator == nullptr) abort();
+  accumulator->num_rho = num_rho;
+  accumulator->num_theta = num_theta;
+  accumulator->votes = scratch->Allocate(num_rho * num_theta);
+  fill(accumulator->votes, accumulator->votes + num_rho * num_theta, 0);
+}
+
+/**
+ * HoughAccumulatorSizeForImage( ) computes the bins HoughTransform( ) uses
+ * for an image of num_rows x num_columns
+ * @param num_rows    image height
+ * @param num_columns image width
+ * @param num_rho     resulting number of rho bins
+ * @param num_theta   resulting number of theta bins
+ * @return false if the accumulator would have more bins than fit a 32-bit
+ *         int, true otherwise
+ */
+bool HoughAccumulatorSizeForImage(size_t num_rows, size_t num_columns,
+  size_t *num_rho, size_t *num_theta){
+  if (num_rho == nullptr || num_theta == nullptr) abort();
+  // the maximum height depends on the image size
+  // the width contain 360 bins
+  const double diagonal = sqrt(double(num_rows) * num_rows +
+                               double(num_columns) * num_columns);
+  *num_theta = 360;
+  if (diagonal * *num_theta > INT32_MAX) return false;
+  *num_rho = diagonal;
+  return true;
+}
+
+/**
+ * AllocateHoughAccumulatorForImage( ) sets accumulator to the bins
+ * HoughTransform( ) uses for an image of num_rows x num_columns, all 0
+ * @param num_rows    image height
+ * @param num_columns image width
+ * @param scratch     memory for the votes
+ * @param accumulator resulting accumulator
+ * @return false if the image is too large, true otherwise
+ */
+bool AllocateHoughAccumulatorForImage(size_t num_rows, size_t num_columns,
+  ScratchArena *scratch, HoughAccumulator *accumulator){
+  size_t accu_row, accu_col;
+  if (!HoughAccumulatorSizeForImage(num_rows, num_columns, &accu_row,
+                                    &accu_col)) return false;
+  AllocateHoughAccumulator(accu_row, accu_col, scratch, accumulator);
+  return true;
+}
+
+/**
+ * VoteHoughAccumulator( ) adds the votes of every non-zero pixel of
+ * binary_image to accumulator. binary_image may be a tile of a larger
+ * image: pixel (i, j) votes as pixel (row_offset + i, column_offset + j)
+ * of the larger image, whose accumulator this is.
+ * @param binary_image  input binary image
+ * @param row_offset    row of binary_image's top-left pixel
+ * @param column_offset column of binary_image's top-left pixel
+ * @param accumulator   accumulator the votes are added to
+ * @param scratch       memory for the edge pixels; temporary if nullptr
+ */
+void VoteHoughAccumulator(const Image &binary_image, size_t row_offset,
+  size_t column_offset, HoughAccumulator *accumulator, ScratchArena *scratch){
+  if (accumulator == nullptr) abort();
+  ScratchArena temporary_scratch;
+  VoteHough(binary_image, row_offset, column_offset, accumulator,
+            scratch != nullptr ? scratch : &temporary_scratch);
+}
+
+/**
+ * VoteHoughAccumulatorWithKernels( ) adds the votes of the non-zero pixels
+ * of binary_image to accumulator the kKernelVoting way
+ * @param binary_image input binary image
+ * @param parameters   clustering parameters
+ * @param accumulator  accumulator the votes are added to
+ * @param scratch      memory for the chains; temporary if nullptr
+ */
+void VoteHoughAccumulatorWithKernels(const Image &binary_image,
+  const KernelHoughParameters &parameters, HoughAccumulator *accumulator,
+  ScratchArena *scratch){
+  if (accumulator == nullptr) abort();
+  ScratchArena temporary_scratch;
+  VoteHoughWithKernels(binary_image, parameters,
+                       scratch != nullptr ? scratch : &temporary_scratch,
+                       accumulator);
+}
+
+/**
+ * WriteHoughVotingArray( ) writes accumulator in the text format of
+ * HoughTransform( )
+ * @param accumulator hough voting array
+ * @param output_file output accumulator array to txt file
+ */
+void WriteHoughVotingArray(const HoughAccumulator &accumulator,
+  std::ostream &output_file){
+  // output header for file
+  output_file << accumulator.num_rho << " " << accumulator.num_theta << endl;
+  for(size_t y = 0; y < accumulator.num_rho; y++){
+    for(size_t x = 0; x < accumulator.num_theta; x++){
+      output_file << accumulator.At(y, x) << " ";
+    }
+  }
+  output_file << endl;
+}
+
+/**
+ * ReadHoughVotingArray( ) reads a hough voting array written by
+ * HoughTransform( )
+ * @param input_hough_voting_array file containing the accumulator
+ * @param scratch                  memory for the votes
+ * @param accumulator              resulting accumulator
+ * @return true if everything is OK, false otherwise
+ */
+bool ReadHoughVotingArray(const string &input_hough_voting_array,
+  ScratchArena *scratch, HoughAccumulator *accumulator){
+  ifstream accumulator_values(input_hough_voting_array);
+  if (accumulator_values.fail()) return false;
 
   // recreate the accumulator array from input file
-  stringstream header(line);
   int accu_row, accu_col;
-  header >> accu_row >> accu_col;
-  std::vector<std::vector<int>> accumulator(accu_row, std::vector<int>(accu_col, 0));
-  getline(accumulator_values, line);
-  stringstream number_stream(line);
+  if (!(accumulator_values >> accu_row >> accu_col) ||
+      accu_row < 0 || accu_col < 0) return false;
+  AllocateHoughAccumulator(accu_row, accu_col, scratch, accumulator);
   for (int i = 0; i < accu_row; ++i){
     for (int j = 0; j < accu_col; ++j){
-      int token;
-      number_stream >> token;
-      accumulator[i][j] = token;
+      if (!(accumulator_values >> accumulator->At(i, j))) return false;
     }
   }
-  // lines array that will contain object edges
-  std::vector< std::pair< std::pair<int, int>, std::pair<int, int> > > lines;
+  return true;
+}
+
+/**
+ * WritePartialHoughAccumulator( ) writes the accumulator of one tile of an
+ * image to a binary file
+ * @param output_filename partial accumulator file
+ * @param shard           the tile
+ * @param accumulator     hough voting array
+ * @return true if everything is OK, false otherwise
+ */
+bool WritePartialHoughAccumulator(const string &output_filename,
+  const HoughShard &shard, const HoughAccumulator &accumulator){
+  const size_t header_values[7] = {shard.num_rows, shard.num_columns,
+                                   shard.grid_rows, shard.grid_columns,
+                                   shard.index, accumulator.num_rho,
+                                   accumulator.num_theta};
+  int32_t header[7];
+  for (int k = 0; k < 7; ++k) {
+    if (header_values[k] > INT32_MAX) {
+      cout << "WritePartialHoughAccumulator: too large" << endl;
+      return false;
+    }
+    header[k] = header_values[k];
+  }
+  FILE *output = fopen(output_filename.c_str(), "wb");
+  if (output == 0) {
+    cout << "WritePartialHoughAccumulator: cannot open file" << endl;
+    return false;
+  }
+  bool written = fwrite("HGA1", 1, 4, output) == 4 &&
+                 fwrite(header, sizeof header, 1, output) == 1;
+  // only the band of rhos with votes, theta by theta
+  std::vector<int32_t> votes;
+  for (size_t t = 0; written && t < accumulator.num_theta; ++t) {
+    size_t first_r = 0;
+    size_t last_r = accumulator.num_rho;
+    while (first_r < last_r && accumulator.At(first_r, t) == 0) ++first_r;
+    while (last_r > first_r && accumulator.At(last_r - 1, t) == 0) --last_r;
+    const int32_t band[2] = {int32_t(first_r), int32_t(last_r - first_r)};
+    votes.clear();
+    for (size_t r = first_r; r < last_r; ++r)
+      votes.push_back(accumulator.At(r, t));
+    written = fwrite(band, sizeof band, 1, output) == 1 &&
+              fwrite(votes.data(), sizeof(int32_t), votes.size(), output) ==
+              votes.size();
+  }
+  if (fclose(output) != 0 || !written) {
+    cout << "WritePartialHoughAccumulator: could not write" << endl;
+    return false;
+  }
+  return true;
+}
+
+/**
+ * MergePartialHoughAccumulator( ) adds the votes of a file written by
+ * WritePartialHoughAccumulator( ) to accumulator, and sets shard to the
+ * file's tile
+ * @param input_filename partial accumulator file
+ * @param scratch        memory for the votes
+ * @param shard          the tile
+ * @param accumulator    accumulator the votes are added to
+ * @return true if everything is OK, false otherwise
+ */
+bool MergePartialHoughAccumulator(const string &input_filename,
+  ScratchArena *scratch, HoughShard *shard, HoughAccumulator *accumulator){
+  if (shard == nullptr || accumulator == nullptr) abort();
+  FILE *input = fopen(input_filename.c_str(), "rb");
+  if (input == 0) {
+    cout << "MergePartialHoughAccumulator: Cannot open file" << endl;
+    return false;
+  }
+
+  // Check for the right "magic number" and sizes.
+  char magic[4];
+  int32_t header[7];
+  bool valid = fread(magic, 1, 4, input) == 4 && !strncmp(magic, "HGA1", 4) &&
+               fread(header, sizeof header, 1, input) == 1;
+  for (int k = 0; valid && k < 7; ++k)
+    valid = header[k] >= 0;
+  valid = valid && header[2] > 0 && header[3] > 0 &&
+          header[4] < int64_t(header[2]) * header[3] &&
+          int64_t(header[5]) * header[6] <= INT32_MAX;
+  if (!valid) {
+    fclose(input);
+    cout << "MergePartialHoughAccumulator: Expected partial accumulator" << endl;
+    return false;
+  }
+  if (accumulator->votes == nullptr) {
+    shard->num_rows = header[0];
+    shard->num_columns = header[1];
+    shard->grid_rows = header[2];
+    shard->grid_columns = header[3];
+    AllocateHoughAccumulator(header[5], header[6], scratch, accumulator);
+  } else if (size_t(header[0]) != shard->num_rows ||
+             size_t(header[1]) != shard->num_columns ||
+             size_t(header[2]) != shard->grid_rows ||
+             size_t(header[3]) != shard->grid_columns ||
+             size_t(header[5]) != accumulator->num_rho ||
+             size_t(header[6]) != accumulator->num_theta) {
+    fclose(input);
+    cout << "MergePartialHoughAccumulator: Different image or grid" << endl;
+    return false;
+  }
+  shard->index = header[4];
+
+  // add the band of votes of every theta
+  std::vector<int32_t> votes;
+  for (size_t t = 0; t < accumulator->num_theta; ++t) {
+    int32_t band[2];
+    if (fread(band, sizeof band, 1, input) != 1) {
+      fclose(input);
+      cout << "MergePartialHoughAccumulator: short file" << endl;
+      return false;
+    }
+    if (band[0] < 0 || band[1] < 0 ||
+        int64_t(band[0]) + band[1] > int64_t(accumulator->num_rho)) {
+      fclose(input);
+      cout << "MergePartialHoughAccumulator: Expected partial accumulator" << endl;
+      return false;
+    }
+    votes.resize(band[1]);
+    if (fread(votes.data(), sizeof(int32_t), votes.size(), input) !=
+        votes.size()) {
+      fclose(input);
+      cout << "MergePartialHoughAccumulator: short file" << endl;
+      return false;
+    }
+    for (int32_t k = 0; k < band[1]; ++k)
+      accumulator->At(band[0] + k, t) += votes[k];
+  }
+
+  fclose(input);
+  return true;
+}
+
+// Clips the line x cos(angle) + y sin(angle) = distance to the image of
+// num_rows x num_columns (Liang-Barsky). Returns false if the line misses it.
+static bool ClipLine(double distance, double angle, size_t num_rows,
+  size_t num_columns, DetectedLine *line){
+  // points on the line are (x, y) = origin + s * direction
+  const double origin[2] = {distance * cos(angle), distance * sin(angle)};
+  const double direction[2] = {-sin(angle), cos(angle)};
+  const double limit[2] = {num_columns - 1.0, num_rows - 1.0};
+  double s_min = -HUGE_VAL;
+  double s_max = HUGE_VAL;
+  for (int axis = 0; axis < 2; ++axis) {
+    if (fabs(direction[axis]) < 1e-9) {
+      if (origin[axis] < 0 || origin[axis] > limit[axis]) return false;
+      continue;
+    }
+    double s0 = (0 - origin[axis]) / direction[axis];
+    double s1 = (limit[axis] - origin[axis]) / direction[axis];
+    if (s0 > s1) swap(s0, s1);
+    s_min = max(s_min, s0);
+    s_max = min(s_max, s1);
+  }
+  if (s_min > s_max) return false;
+
+  const int last_column = num_columns - 1;
+  const int last_row = num_rows - 1;
+  line->x0 = min(max(0, int(lround(origin[0] + s_min * direction[0]))), last_column);
+  line->y0 = min(max(0, int(lround(origin[1] + s_min * direction[1]))), last_row);
+  line->x1 = min(max(0, int(lround(origin[0] + s_max * direction[0]))), last_column);
+  line->y1 = min(max(0, int(lround(origin[1] + s_max * direction[1]))), last_row);
+  return true;
+}
+
+/**
+ * DetectLines( ) finds the local maxima of the accumulator that are on or
+ * above threshold_value, and clips the corresponding lines to an image of
+ * num_rows x num_columns
+ * @param accumulator     hough voting array
+ * @param threshold_value threshold value for computing maxima
+ * @param num_rows        image height
+ * @param num_columns     image width
+ * @param lines           resulting lines
+ */
+void DetectLines(const HoughAccumulator &accumulator, int threshold_value,
+  size_t num_rows, size_t num_columns, std::vector<DetectedLine> *lines){
+  if (lines == nullptr) abort();
+  lines->clear();
+  if (num_rows == 0 || num_columns == 0) return;
+  const int accu_row = accumulator.num_rho;
+  const int accu_col = accumulator.num_theta;
+  double pi = atan(1)*4;
+  double theta = (pi/accu_col);
   int max = 0;
   // loop over the accumulator to check if the value of a bin
   // is on or above threshold_value
   for(int r=0;r<accu_row;r++){
     for(int t=0;t<accu_col;t++){
-      if(accumulator[r][t] >= threshold_value){
+      if(accumulator.At(r, t) >= threshold_value){
         // check if this point is a local maxima
-        max = accumulator[r][t];
+        max = accumulator.At(r, t);
         for(int ly=-4;ly<=4;ly++){
           for(int lx=-4;lx<=4;lx++){
             if( (ly+r>=0 && ly+r<accu_row) && (lx+t>=0 && lx+t<accu_col) ){
-              if( accumulator[ly+r][lx+t] > max ){
-                max = accumulator[ly+r][lx+t];
+              if( accumulator.At(ly+r, lx+t) > max ){
+                max = accumulator.At(ly+r, lx+t);
                 ly = lx = 5;
               }
             }
           }
         }
-        if(max > accumulator[r][t])
+        if(max > accumulator.At(r, t))
           continue;
 
-        // (r, θ) coordinates are computed back to two points in image space
-        int x1, y1, x2, y2;
-        x1 = y1 = x2 = y2 = 0;
-        double pi = atan(1)*4;
-        double theta = (pi/360);
-        if((t >= 45 && t <= 135) || (t >= 225 && t <= 315)){
-          //y = (r - x cos(t)) / sin(t)
-          x1 = 0;
-          y1 = ( (r - (x1*cos(t*theta)) ) / sin(t * theta));
-          x2 = column - 0;
-          y2 = ( (r - (x2*cos(t * theta)) ) / sin(t * theta));
-        }
-        else{
-          //x = (r - y sin(t)) / cos(t);
-          y1 = 0;
-          x1 = ((r - (y1*sin(t*theta)) ) / cos(t * theta));
-          y2 = row - 0;
-          x2 = ((r-(y2*sin(t*theta)) ) / cos(t * theta));
-        }
-        lines.push_back(std::pair< std::pair<int, int>, std::pair<int, int> >(std::pair<int, int>(x1,y1), std::pair<int, int>(x2,y2)));
+        // (r, θ) is computed back to the segment of the line in the image;
+        // votes for r come from [r, r+1), so use the middle of the bin
+        DetectedLine line;
+        line.rho = r + 0.5;
+        line.theta = t * 180.0 / accu_col;
+        line.votes = accumulator.At(r, t);
+        if (ClipLine(line.rho, t * theta, num_rows, num_columns, &line))
+          lines->push_back(line);
       }
     }
   }
-  // draw the computed lines to the input image
-  std::vector< std::pair< std::pair<int, int>, std::pair<int, int> > >::iterator it;
-  for(it=lines.begin();it!=lines.end();it++){
-    if (abs(it->first.second) > column)
-    {
-      DrawLine(abs(it->first.first), column, abs(it->second.first), abs(it->second.second), 255, an_image);
-    }
-    else if (abs(it->second.second) > column)
-    {
-      DrawLine(abs(it->first.first), abs(it->first.second), abs(it->second.first), column, 255, an_image);
-    }
-    else if (abs(it->second.second) > column && abs(it->first.first) > column)
-    {
-      DrawLine(abs(it->first.first), column, abs(it->second.first), column, 255, an_image);
-    }
-    else
-      DrawLine(abs(it->first.first), abs(it->first.second), abs(it->second.first), abs(it->second.second), 255, an_image);
+}
+
+/**
+ * DrawLines( ) draws the given lines on the image
+ * @param lines    lines found by DetectLines( )
+ * @param color    gray level of the lines
+ * @param an_image image the lines will be drawn on
+ */
+void DrawLines(const std::vector<DetectedLine> &lines, int color,
+  Image *an_image){
+  if (an_image == nullptr) abort();
+  // DrawLine( ) takes (row, column) points
+  for (size_t i = 0; i < lines.size(); ++i)
+    DrawLine(lines[i].y0, lines[i].x0, lines[i].y1, lines[i].x1, color,
+             an_image);
+}
+
+/**
+ * LineFormatFromFilename( ) picks the line format from the extension of
+ * filename: .csv, .json or .bin
+ * @param filename file name
+ * @param format   resulting format
+ * @return true if the extension is known, false otherwise
+ */
+bool LineFormatFromFilename(const string &filename, LineFormat *format){
+  if (format == nullptr) abort();
+  const size_t dot = filename.rfind('.');
+  if (dot == string::npos) return false;
+  const string extension = filename.substr(dot);
+  if (extension == ".csv")
+    *format = kLineFormatCsv;
+  else if (extension == ".json")
+    *format = kLineFormatJson;
+  else if (extension == ".bin")
+    *format = kLineFormatBinary;
+  else
+    return false;
+  return true;
+}
+
+/**
+ * WriteLines( ) writes lines to output_file in the given format
+ * @param lines       lines found by DetectLines( )
+ * @param format      output format
+ * @param output_file output stream, opened in binary mode for
+ *                    kLineFormatBinary
+ */
+void WriteLines(const std::vector<DetectedLine> &lines, LineFormat format,
+  std::ostream &output_file){
+  // rho and theta in full: 6 digits would round the rho of a large image.
+  // The caller's format is restored at the end.
+  const ios::fmtflags flags = output_file.flags();
+  const streamsize precision = output_file.precision();
+  output_file.unsetf(ios::floatfield);
+  output_file.precision(numeric_limits<double>::max_digits10);
+  switch (format) {
+    case kLineFormatCsv:
+      output_file << "rho_px,theta_deg,votes,x0,y0,x1,y1\n";
+      for (size_t i = 0; i < lines.size(); ++i) {
+        const DetectedLine &line = lines[i];
+        output_file << line.rho << "," << line.theta << "," << line.votes
+                    << "," << line.x0 << "," << line.y0 << "," << line.x1
+                    << "," << line.y1 << "\n";
+      }
+      break;
+
+    case kLineFormatJson:
+      output_file << "[";
+      for (size_t i = 0; i < lines.size(); ++i) {
+        const DetectedLine &line = lines[i];
+        output_file << (i == 0 ? "\n" : ",\n")
+                    << "  {\"rho_px\": " << line.rho
+                    << ", \"theta_deg\": " << line.theta
+                    << ", \"votes\": " << line.votes
+                    << ", \"x0\": " << line.x0 << ", \"y0\": " << line.y0
+                    << ", \"x1\": " << line.x1 << ", \"y1\": " << line.y1
+                    << "}";
+      }
+      output_file << "\n]\n";
+      break;
+
+    case kLineFormatBinary:
+      output_file.write("HLN1", 4);
+      for (size_t i = 0; i < lines.size(); ++i) {
+        const DetectedLine &line = lines[i];
+        const double parameters[2] = {line.rho, line.theta};
+        const int32_t record[5] = {line.votes, line.x0, line.y0, line.x1,
+                                   line.y1};
+        output_file.write(reinterpret_cast<const char *>(parameters),
+                          sizeof parameters);
+        output_file.write(reinterpret_cast<const char *>(record),
+                          sizeof record);
+      }
+      break;
   }
+  output_file.flags(flags);
+  output_file.precision(precision);
 }
 }  // namespace ComputerVisionProjects
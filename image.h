@@ -8,6 +8,7 @@
 #include <cstdlib>
 #include <string>
 #include <fstream>
+#include <vector>
 
 namespace ComputerVisionProjects {
 
@@ -25,15 +26,20 @@ namespace ComputerVisionProjects {
 class Image {
  public:
   Image(): num_rows_{0}, num_columns_{0},
-	   num_gray_levels_{0}, pixels_{nullptr} { }
+	   num_gray_levels_{0}, pixels_{nullptr}, data_{nullptr} { }
 
   Image(const Image &an_image);
   Image& operator=(const Image &an_image) = delete;
 
+  // Moving an image hands over its pixels without copying them.
+  Image(Image &&an_image) noexcept;
+  Image& operator=(Image &&an_image) noexcept;
+
   ~Image();
 
   // Sets the size of the image to the given
   // height (num_rows) and columns (num_columns).
+  // Keeps the current pixels (and their values) if the size is unchanged.
   void AllocateSpaceAndSetSize(size_t num_rows, size_t num_columns);
 
   size_t num_rows() const { return num_rows_; }
@@ -73,14 +79,216 @@ class Image {
   size_t num_rows_;
   size_t num_columns_;
   size_t num_gray_levels_;
+  // Row pointers into data_, which holds all pixels contiguously.
   int **pixels_;
+  int *data_;
+};
+
+// Read-only view of an 8-bit gray-scale image that does not own its pixels.
+// Consecutive rows are stride bytes apart.
+// Sample usage:
+//   MappedImage mapped_image;
+//   if (MapImage("input_file.pgm", &mapped_image))
+//     LocateEdges(mapped_image.view(), &edge_image);
+class ImageView {
+ public:
+  ImageView(): pixels_{nullptr}, num_rows_{0}, num_columns_{0},
+	       stride_{0}, num_gray_levels_{0} { }
+
+  ImageView(const unsigned char *pixels, size_t num_rows, size_t num_columns,
+	    size_t stride, size_t num_gray_levels):
+      pixels_{pixels}, num_rows_{num_rows}, num_columns_{num_columns},
+      stride_{stride}, num_gray_levels_{num_gray_levels} { }
+
+  size_t num_rows() const { return num_rows_; }
+  size_t num_columns() const { return num_columns_; }
+  size_t stride() const { return stride_; }
+  size_t num_gray_levels() const { return num_gray_levels_; }
+
+  int GetPixel(size_t i, size_t j) const {
+    if (i >= num_rows_ || j >= num_columns_) abort();
+    return pixels_[i * stride_ + j];
+  }
+
+  // Returns the view of the num_rows x num_columns block of this view
+  // whose top-left pixel is (i, j).
+  ImageView SubView(size_t i, size_t j, size_t num_rows,
+		    size_t num_columns) const {
+    if (i + num_rows > num_rows_ || j + num_columns > num_columns_) abort();
+    return ImageView(pixels_ + i * stride_ + j, num_rows, num_columns,
+		     stride_, num_gray_levels_);
+  }
+
+ private:
+  const unsigned char *pixels_;
+  size_t num_rows_;
+  size_t num_columns_;
+  size_t stride_;
+  size_t num_gray_levels_;
 };
 
+// Read-only memory mapping of a binary pgm file. view() points straight
+// at the pixel payload after the header, and stays valid for as long as
+// the MappedImage does.
+class MappedImage {
+ public:
+  MappedImage(): mapping_{nullptr}, mapping_size_{0} { }
+
+  MappedImage(const MappedImage &a_mapped_image) = delete;
+  MappedImage& operator=(const MappedImage &a_mapped_image) = delete;
+
+  ~MappedImage();
+
+  const ImageView& view() const { return view_; }
+
+ private:
+  friend bool MapImage(const std::string &input_filename,
+		       MappedImage *mapped_image);
+
+  void Unmap();
+
+  void *mapping_;
+  size_t mapping_size_;
+  ImageView view_;
+};
+
+// Scratch memory for the temporaries of the pipeline stages (gradient
+// planes, Hough accumulators). The caller owns it and can reuse it across
+// frames: memory handed out by Allocate() stays valid until the next
+// Reset(), which keeps a single block large enough for everything
+// allocated since the previous Reset(). After the first frame the stages
+// therefore allocate nothing.
+// Sample usage:
+//   ScratchArena scratch;
+//   for (...) {  // every frame
+//     scratch.Reset();
+//     LocateEdges(&an_image, &scratch);
+//   }
+class ScratchArena {
+ public:
+  ScratchArena(): block_{nullptr}, block_size_{0}, used_{0} { }
+
+  ScratchArena(const ScratchArena &a_scratch_arena) = delete;
+  ScratchArena& operator=(const ScratchArena &a_scratch_arena) = delete;
+
+  ~ScratchArena();
+
+  // Returns space for count ints. Its contents are unspecified.
+  int *Allocate(size_t count) {
+    return static_cast<int *>(AllocateBytes(count * sizeof(int)));
+  }
+
+  // Returns space for count doubles. Its contents are unspecified.
+  double *AllocateDoubles(size_t count) {
+    return static_cast<double *>(AllocateBytes(count * sizeof(double)));
+  }
+
+  // Releases everything allocated so far, keeping the memory for reuse.
+  void Reset();
+
+  // In bytes.
+  size_t capacity() const { return block_size_; }
+
+ private:
+  // Returns size bytes, aligned for any of the types above.
+  void *AllocateBytes(size_t size);
+  void DeallocateSpace();
+
+  unsigned char *block_;
+  size_t block_size_;
+  // Bytes handed out since the last Reset(), including those in overflow_.
+  size_t used_;
+  // Blocks allocated once block_ ran out; merged into block_ by Reset().
+  std::vector<unsigned char *> overflow_;
+};
+
+// Hough voting array of num_rho x num_theta bins; theta bin t stands for
+// the angle t * pi / num_theta. The votes are stored theta by theta, so
+// that the votes for one theta are a contiguous strip of num_rho ints.
+// Does not own its votes, which normally come from a ScratchArena (see
+// AllocateHoughAccumulator()).
+struct HoughAccumulator {
+  HoughAccumulator(): num_rho{0}, num_theta{0}, votes{nullptr} { }
+
+  int& At(size_t rho, size_t theta) {
+    return votes[theta * num_rho + rho];
+  }
+  int At(size_t rho, size_t theta) const {
+    return votes[theta * num_rho + rho];
+  }
+
+  size_t num_rho;
+  size_t num_theta;
+  int *votes;
+};
+
+// One tile of an image split into a grid of grid_rows x grid_columns
+// tiles, numbered row by row from 0 (see WritePartialHoughAccumulator()).
+struct HoughShard {
+  HoughShard(): num_rows{0}, num_columns{0}, grid_rows{0},
+      grid_columns{0}, index{0} { }
+
+  // Size of the whole image.
+  size_t num_rows;
+  size_t num_columns;
+  size_t grid_rows;
+  size_t grid_columns;
+  size_t index;
+};
+
+// A line found in a HoughAccumulator: x cos(theta) + y sin(theta) = rho,
+// with x the column and y the row, rho in pixels and theta in degrees.
+// (x0, y0)-(x1, y1) is the part of the line inside the image.
+struct DetectedLine {
+  double rho;
+  double theta;
+  int votes;
+  int x0;
+  int y0;
+  int x1;
+  int y1;
+};
+
+// How a binary image votes in the Hough space.
+//   kStandardVoting: every non-zero pixel votes once for every theta.
+//   kKernelVoting:   non-zero pixels are linked into chains, the chains
+//                    are split into approximately collinear clusters, and
+//                    every cluster deposits one gaussian kernel of votes
+//                    around the line fitted to it (see
+//                    VoteHoughAccumulatorWithKernels()).
+enum HoughVotingMode { kStandardVoting, kKernelVoting };
+
+// Parameters of kKernelVoting.
+struct KernelHoughParameters {
+  KernelHoughParameters(): min_cluster_size{10}, max_deviation{2.0} { }
+
+  // Clusters of fewer pixels do not vote; at least 3 is used.
+  size_t min_cluster_size;
+  // A chain is split until no pixel of a cluster is farther than this from
+  // the segment joining the cluster's ends, in pixels; at least 0 is used.
+  double max_deviation;
+};
+
+// Formats for writing a list of DetectedLine's (see WriteLines()).
+//   kLineFormatCsv:    a "rho_px,theta_deg,votes,x0,y0,x1,y1" header,
+//                      then one line per DetectedLine; rho and theta
+//                      are written with all the digits of a double.
+//   kLineFormatJson:   an array of objects with the same keys.
+//   kLineFormatBinary: the 4 bytes "HLN1", then per DetectedLine rho and
+//                      theta as 64-bit doubles followed by votes, x0, y0,
+//                      x1 and y1 as 32-bit ints, all in host byte order.
+enum LineFormat { kLineFormatCsv, kLineFormatJson, kLineFormatBinary };
+
 // Reads a pgm image from file input_filename.
 // an_image is the resulting image.
 // Returns true if  everyhing is OK, false otherwise.
 bool ReadImage(const std::string &input_filename, Image *an_image);
 
+// Maps the 8-bit pgm image input_filename into memory without copying it.
+// mapped_image is the resulting mapping.
+// Returns true if  everyhing is OK, false otherwise.
+bool MapImage(const std::string &input_filename, MappedImage *mapped_image);
+
 // Writes image an_iamge into the pgm file output_filename.
 // Returns true if  everyhing is OK, false otherwise.
 bool WriteImage(const std::string &output_filename, const Image &an_image);
@@ -106,8 +314,22 @@ void ConvertToBinary(const int threshold_value, Image *an_image);
  * image based on the gradient approximation of sobel derivatives.
  *
  * @param {Image} an_image: input image
+ * @param {ScratchArena} scratch: memory for the gradient planes; a
+ *   temporary one is used if nullptr
  */
-void LocateEdges(Image *an_image);
+void LocateEdges(Image *an_image, ScratchArena *scratch = nullptr);
+
+/**
+ * LocateEdges( ) same as above, but reads input_image and writes the
+ * gradient approximation to edge_image, leaving input_image untouched.
+ *
+ * @param {ImageView} input_image: input image
+ * @param {Image} edge_image: output edge image
+ * @param {ScratchArena} scratch: memory for the gradient planes; a
+ *   temporary one is used if nullptr
+ */
+void LocateEdges(const ImageView &input_image, Image *edge_image,
+        ScratchArena *scratch = nullptr);
 
 /**
  * HoughTransform( ) creates an accumulator array of the hough space and
@@ -115,9 +337,24 @@ void LocateEdges(Image *an_image);
  * @param an_image    [input binary image]
  * @param hough_image [output hough image used for visualization]
  * @param output_file [output accumulator array to txt file]
+ * @param scratch     [memory for the accumulator; temporary if nullptr]
+ * @param mode        [how the pixels vote]
  */
 void HoughTransform(Image *an_image, Image *hough_image,
-        std::ostream &output_file);
+        std::ostream &output_file, ScratchArena *scratch = nullptr,
+        HoughVotingMode mode = kStandardVoting);
+
+/**
+ * HoughTransform( ) same as above, for a binary image that is only viewed
+ * @param an_image    [input binary image]
+ * @param hough_image [output hough image used for visualization]
+ * @param output_file [output accumulator array to txt file]
+ * @param scratch     [memory for the accumulator; temporary if nullptr]
+ * @param mode        [how the pixels vote]
+ */
+void HoughTransform(const ImageView &an_image, Image *hough_image,
+        std::ostream &output_file, ScratchArena *scratch = nullptr,
+        HoughVotingMode mode = kStandardVoting);
 
 /**
  * DrawDetectedLines( ) takes in hough voting array, recalculates points
@@ -125,9 +362,178 @@ void HoughTransform(Image *an_image, Image *hough_image,
  * @param input_hough_voting_array array containing the accumulator
  * @param threshold_value          threshold value for computing maxima
  * @param an_image                 image the lines will be drawn on
+ * @param scratch                  memory for the accumulator; temporary
+ *                                 if nullptr
  */
 void DrawDetectedLines(const std::string input_hough_voting_array,
-        int threshold_value, Image *an_image);
+        int threshold_value, Image *an_image,
+        ScratchArena *scratch = nullptr);
+
+/**
+ * AllocateHoughAccumulator( ) sets accumulator to num_rho x num_theta bins
+ * taken from scratch, all 0
+ * @param num_rho     number of rho bins
+ * @param num_theta   number of theta bins
+ * @param scratch     memory for the votes
+ * @param accumulator resulting accumulator
+ */
+void AllocateHoughAccumulator(size_t num_rho, size_t num_theta,
+        ScratchArena *scratch, HoughAccumulator *accumulator);
+
+/**
+ * HoughAccumulatorSizeForImage( ) computes the bins HoughTransform( ) uses
+ * for an image of num_rows x num_columns: one rho bin per pixel of its
+ * diagonal, and 360 theta bins
+ * @param num_rows    image height
+ * @param num_columns image width
+ * @param num_rho     resulting number of rho bins
+ * @param num_theta   resulting number of theta bins
+ * @return false if the accumulator would have more bins than fit a 32-bit
+ *         int, true otherwise
+ */
+bool HoughAccumulatorSizeForImage(size_t num_rows, size_t num_columns,
+        size_t *num_rho, size_t *num_theta);
+
+/**
+ * AllocateHoughAccumulatorForImage( ) sets accumulator to the bins
+ * HoughTransform( ) uses for an image of num_rows x num_columns, all 0
+ * @param num_rows    image height
+ * @param num_columns image width
+ * @param scratch     memory for the votes
+ * @param accumulator resulting accumulator
+ * @return false if the image is too large (see
+ *         HoughAccumulatorSizeForImage( )), true otherwise
+ */
+bool AllocateHoughAccumulatorForImage(size_t num_rows, size_t num_columns,
+        ScratchArena *scratch, HoughAccumulator *accumulator);
+
+/**
+ * VoteHoughAccumulator( ) adds the votes of every non-zero pixel of
+ * binary_image to accumulator. binary_image may be a tile of a larger
+ * image: pixel (i, j) votes as pixel (row_offset + i, column_offset + j)
+ * of the larger image, whose accumulator this is.
+ * @param binary_image  input binary image
+ * @param row_offset    row of binary_image's top-left pixel
+ * @param column_offset column of binary_image's top-left pixel
+ * @param accumulator   accumulator the votes are added to
+ * @param scratch       memory for the edge pixels; temporary if nullptr
+ */
+void VoteHoughAccumulator(const Image &binary_image, size_t row_offset,
+        size_t column_offset, HoughAccumulator *accumulator,
+        ScratchArena *scratch = nullptr);
+
+/**
+ * VoteHoughAccumulatorWithKernels( ) adds the votes of the non-zero pixels
+ * of binary_image to accumulator the kKernelVoting way: 8-connected pixels
+ * are linked into chains, each chain is split at the pixel farthest from
+ * the segment joining its ends until every part is within
+ * parameters.max_deviation of it, and each part with at least
+ * parameters.min_cluster_size pixels casts a gaussian kernel of votes
+ * centered on its least-squares line and shaped by the uncertainty of the
+ * fit, with a peak of about its number of pixels
+ * @param binary_image input binary image
+ * @param parameters   clustering parameters
+ * @param accumulator  accumulator the votes are added to
+ * @param scratch      memory for the chains; temporary if nullptr
+ */
+void VoteHoughAccumulatorWithKernels(const Image &binary_image,
+        const KernelHoughParameters &parameters,
+        HoughAccumulator *accumulator, ScratchArena *scratch = nullptr);
+
+/**
+ * WriteHoughVotingArray( ) writes accumulator in the text format of
+ * HoughTransform( )
+ * @param accumulator hough voting array
+ * @param output_file output accumulator array to txt file
+ */
+void WriteHoughVotingArray(const HoughAccumulator &accumulator,
+        std::ostream &output_file);
+
+/**
+ * ReadHoughVotingArray( ) reads a hough voting array written by
+ * HoughTransform( )
+ * @param input_hough_voting_array file containing the accumulator
+ * @param scratch                  memory for the votes
+ * @param accumulator              resulting accumulator
+ * @return true if everything is OK, false otherwise
+ */
+bool ReadHoughVotingArray(const std::string &input_hough_voting_array,
+        ScratchArena *scratch, HoughAccumulator *accumulator);
+
+/**
+ * WritePartialHoughAccumulator( ) writes the accumulator of one tile of an
+ * image to a binary file: the 4 bytes "HGA1", then the num_rows and
+ * num_columns of the whole image, the grid_rows, grid_columns and index of
+ * the tile, num_rho and num_theta, then for every theta the first rho and
+ * the number of rhos of the band holding its non-zero votes, followed by
+ * the votes of the band, all as 32-bit ints in host byte order. A tile
+ * only votes near the projections of its corners on each theta, so the
+ * file is much smaller than the accumulator.
+ * @param output_filename partial accumulator file
+ * @param shard           the tile
+ * @param accumulator     hough voting array
+ * @return true if everything is OK, false otherwise
+ */
+bool WritePartialHoughAccumulator(const std::string &output_filename,
+        const HoughShard &shard, const HoughAccumulator &accumulator);
+
+/**
+ * MergePartialHoughAccumulator( ) adds the votes of a file written by
+ * WritePartialHoughAccumulator( ) to accumulator, and sets shard to the
+ * file's tile. If accumulator has no votes yet it is allocated from
+ * scratch first; otherwise the file must be for the same image and grid
+ * as *shard.
+ * @param input_filename partial accumulator file
+ * @param scratch        memory for the votes
+ * @param shard          the tile
+ * @param accumulator    accumulator the votes are added to
+ * @return true if everything is OK, false otherwise
+ */
+bool MergePartialHoughAccumulator(const std::string &input_filename,
+        ScratchArena *scratch, HoughShard *shard,
+        HoughAccumulator *accumulator);
+
+/**
+ * DetectLines( ) finds the local maxima of the accumulator that are on or
+ * above threshold_value, and clips the corresponding lines to an image of
+ * num_rows x num_columns
+ * @param accumulator     hough voting array
+ * @param threshold_value threshold value for computing maxima
+ * @param num_rows        image height
+ * @param num_columns     image width
+ * @param lines           resulting lines
+ */
+void DetectLines(const HoughAccumulator &accumulator, int threshold_value,
+        size_t num_rows, size_t num_columns,
+        std::vector<DetectedLine> *lines);
+
+/**
+ * DrawLines( ) draws the given lines on the image
+ * @param lines    lines found by DetectLines( )
+ * @param color    gray level of the lines
+ * @param an_image image the lines will be drawn on
+ */
+void DrawLines(const std::vector<DetectedLine> &lines, int color,
+        Image *an_image);
+
+/**
+ * LineFormatFromFilename( ) picks the line format from the extension of
+ * filename: .csv, .json or .bin
+ * @param filename file name
+ * @param format   resulting format
+ * @return true if the extension is known, false otherwise
+ */
+bool LineFormatFromFilename(const std::string &filename, LineFormat *format);
+
+/**
+ * WriteLines( ) writes lines to output_file in the given format
+ * @param lines       lines found by DetectLines( )
+ * @param format      output format
+ * @param output_file output stream, opened in binary mode for
+ *                    kLineFormatBinary
+ */
+void WriteLines(const std::vector<DetectedLine> &lines, LineFormat format,
+        std::ostream &output_file);
 
 }  // namespace ComputerVisionProjects
 